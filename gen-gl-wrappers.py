@@ -92,14 +92,6 @@ FUNCTION_PLACEHOLDER = set([
 	"glWaitSync",
 	"glClientWaitSync",
 	
-	# Stuff that needs special handling and is commonly used, but not implemented yet
-	"glMapBuffer",
-	"glUnmapBuffer",
-	"glMapBufferRange",
-	"glMapNamedBuffer",
-	"glMapNamedBufferRange",
-	"glReadPixels",
-	
 	# Useless in modern programs
 	"glFinish",
 	
@@ -148,8 +140,69 @@ FUNCTION_SPECIAL_C = set([
 	"glFlush",
 	"glGetBufferSubData",
 	"glGetBufferParameteriv",
+	"glGetNamedBufferSubData",
+	"glGetNamedBufferParameteriv",
+	"glGetError",
+	"glGetIntegerv",
+	"glIsEnabled",
+	"glReadPixels",
+])
+
+# Functions that are implemented entirely in the tracee, in source-c/tracee/gl/map.c. They don't send a command of
+# their own, so the tracer has no handler for them.
+FUNCTION_TRACEE_ONLY = set([
+	"glMapBuffer",
+	"glMapBufferRange",
+	"glMapNamedBuffer",
+	"glMapNamedBufferRange",
+	"glFlushMappedBufferRange",
+	"glFlushMappedNamedBufferRange",
+	"glUnmapBuffer",
+	"glUnmapNamedBuffer",
 ])
 
+# Functions whose wrappers also update the tracee's copy of the OpenGL state, by calling `lss_shadow_<name>` with
+# the same arguments. See source-c/tracee/gl/shadow.c.
+FUNCTION_SHADOWED = set([
+	"glActiveTexture",
+	"glBindBuffer",
+	"glDeleteBuffers",
+	"glDisable",
+	"glDisablei",
+	"glEnable",
+	"glEnablei",
+	"glPopAttrib",
+	"glPopClientAttrib",
+	"glUseProgram",
+	"glViewport",
+])
+
+# glGen* functions whose names are picked by the tracee, mapped to the counter in `lss_gl_names` that they use.
+# The names don't need to come from the OpenGL implementation, since the tracer maps them to its own names.
+FUNCTION_CLIENT_NAMES = {
+	"glGenBuffers": "buffers",
+	"glGenTextures": "textures",
+}
+
+# Parameters that name OpenGL objects, mapped to the kind of object. The tracer translates these from the tracee's
+# names to its own, using the `IdMaps` table of the same name (source/opengl/idmaps.d).
+# Only GLuint parameters name objects; ex. the `texture` parameter of glActiveTexture is an enum.
+PARAM_OBJECT_KINDS = {
+	"buffer": "buffers",
+	"buffers": "buffers",
+	"texture": "textures",
+	"textures": "textures",
+	"shader": "shaders",
+	"shaders": "shaders",
+	"program": "programs",
+	"array": "vertexArrays",
+	"vaobj": "vertexArrays",
+	"renderbuffer": "renderbuffers",
+	"framebuffer": "framebuffers",
+	"readFramebuffer": "framebuffers",
+	"drawFramebuffer": "framebuffers",
+}
+
 class Param:
 	"""
 	OpenGL function parameter information.
@@ -165,6 +218,16 @@ class Param:
 	
 	def sizeof_c(self):
 		return "sizeof({0})".format(self.name)
+	
+	@property
+	def objectKind(self):
+		"""
+		The kind of OpenGL object that this parameter names, or None.
+		"""
+		basetype = self.ctype.replace("const", "").replace("*", "").strip()
+		if basetype != "GLuint":
+			return None
+		return PARAM_OBJECT_KINDS.get(self.name)
 
 class ParamBuffer(Param):
 	"""
@@ -227,6 +290,12 @@ class GLFunctionBase(metaclass=abc.ABCMeta):
 	@property
 	def numBufferParams(self):
 		return sum(map(lambda x: 1 if isinstance(x, ParamBuffer) else 0, self.params))
+	
+	def objectParams_list(self):
+		"""
+		Lists the parameters that name objects, for the function list, as `index:kind` pairs separated by `;`.
+		"""
+		return ";".join("{0}:{1}".format(i, p.objectKind) for i, p in enumerate(self.params) if p.objectKind)
 
 class GLFunction(GLFunctionBase):
 	"""
@@ -260,6 +329,9 @@ class GLFunction(GLFunctionBase):
 		for param in self.bufferParams:
 			out += "\tif({0} != NULL) queueGlCommand({0}, {1});\n".format(param.name, param.sizeof_c())
 		
+		if self.name in FUNCTION_SHADOWED:
+			out += "\tlss_shadow_{0}({1});\n".format(self.name, ", ".join(p.name for p in self.params))
+		
 		if self.returnType != "void":
 			out += "\tflushGlBuffer();\n"
 			out += "\t{0} _lss_result;\n".format(self.returnType)
@@ -340,6 +412,30 @@ class GLFunctionGen(GLFunctionBase):
 		out += "}\n"
 		return out
 
+class GLFunctionReserve(GLFunctionGen):
+	"""
+	glGen* functions whose names are picked by the tracee. The names are sent to the tracer without waiting for a
+	response.
+	"""
+	type = "reserve"
+	
+	def implementation_c(self):
+		count, names = self.params
+		out  = "EXPORT {0} {1}{2} {{\n".format(self.returnType, self.name, self.paramsString_c())
+		out += "\treserveGlNames(&traceeData->gl.names.{0}, {1}, {2});\n".format(
+			FUNCTION_CLIENT_NAMES[self.name], count.name, names.name)
+		
+		out += "\tstruct {\n\tint _cmd;\n\tGLsizei " + count.name + ";\n\tsize_t _lss_" + names.name + "_size;\n"
+		out += "\t} __attribute__((packed)) _lss_params;\n"
+		out += "\t_lss_params._cmd = (int) _LSS_GL_{0};\n".format(self.name)
+		out += "\t_lss_params.{0} = {0};\n".format(count.name)
+		out += "\t_lss_params._lss_{0}_size = {1};\n".format(names.name, names.sizeof_c())
+		out += "\tqueueGlCommand(&_lss_params, sizeof(_lss_params));\n"
+		out += "\tqueueGlCommand({0}, {1});\n".format(names.name, names.sizeof_c())
+		
+		out += "}\n"
+		return out
+
 class GLFunctionDelete(GLFunction):
 	"""
 	glDelete* functions.
@@ -363,6 +459,12 @@ class GLFunctionSpecial(GLFunction):
 	def implementation_c(self):
 		return ""
 
+class GLFunctionTraceeOnly(GLFunctionSpecial):
+	"""
+	Functions that the tracee implements without sending them to the tracer. No C wrapper.
+	"""
+	type = "tracee"
+
 def parseFunction(funcElem, funcId):
 	"""
 	Parses an XML element from the OpenGL spec, and returns a GLFunctionBase subclass
@@ -391,12 +493,16 @@ def parseFunction(funcElem, funcId):
 			params.append(Param(ctype, paramName, paramElem.attrib.get("group")))
 	
 	aliasElem = funcElem.find("alias")
-	if funcName in FUNCTION_SPECIAL_C:
+	if funcName in FUNCTION_TRACEE_ONLY:
+		return GLFunctionTraceeOnly(funcId, funcName, returnType, params)
+	elif funcName in FUNCTION_SPECIAL_C:
 		return GLFunctionSpecial(funcId, funcName, returnType, params)
 	elif funcName in FUNCTION_PLACEHOLDER or funcName.startswith("glGet") or funcName.endswith("x") or funcName.endswith("xv"):
 		return GLFunctionPlaceholder(funcId, funcName, returnType, params)
 	elif aliasElem is not None:
 		return GLFunctionAlias(funcId, funcName, returnType, params, aliasElem.attrib["name"])
+	elif funcName in FUNCTION_CLIENT_NAMES:
+		return GLFunctionReserve(funcId, funcName, returnType, params)
 	elif funcName.startswith("glGen") and funcName != "glGenLists" and not funcName.startswith("glGenerate"):
 		return GLFunctionGen(funcId, funcName, returnType, params)
 	elif funcName.startswith("glDelete") and funcName not in ("glDeleteLists", "glDeleteShader", "glDeleteProgram"):
@@ -465,6 +571,7 @@ Reads the Khronos OpenGL XML spec from stdin and outputs C overrides for support
 
 #include "tracee.h"
 #include "gl/buffer.h"
+#include "gl/shadow.h"
 
 typedef int GLclampx; // khronos_int32_t
 
@@ -478,4 +585,4 @@ typedef enum {{
 	
 	for func in functions:
 		args.out_c.write(func.implementation_c())
-		args.out_list.write(func.name+","+func.type+","+str(func.id)+"\n")
+		args.out_list.write(func.name+","+func.type+","+str(func.id)+","+func.objectParams_list()+"\n")
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+
+# Measures how many commands per second the tracer runs when driven over its command socket, as with
+# `lss execute --socket <path> <proc>`. Each cycle sends the given commands, pipelined up to a number of cycles
+# ahead of the responses.
+
+import socket
+import time
+
+class CommandClient:
+	def __init__(self, path):
+		self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+		self.sock.connect(path)
+		self.file = self.sock.makefile("rb")
+	
+	def send(self, commands):
+		self.sock.sendall("".join(command + "\n" for command in commands).encode("utf-8"))
+	
+	def receive(self):
+		"""Reads a response, returning its status and output."""
+		header = self.file.readline()
+		if not header:
+			raise EOFError("The tracer closed the socket")
+		status, length = map(int, header.split())
+		return status, self.file.read(length)
+	
+	def run(self, command):
+		self.send([command])
+		return self.receive()
+	
+	def close(self):
+		self.file.close()
+		self.sock.close()
+
+def bench(client, commands, cycles, depth):
+	sent = 0
+	received = 0
+	failures = 0
+	start = time.monotonic()
+	while received < cycles * len(commands):
+		while sent < cycles and sent * len(commands) - received < depth * len(commands):
+			client.send(commands)
+			sent += 1
+		status, output = client.receive()
+		if status != 0:
+			failures += 1
+			if failures == 1:
+				print("Command failed with status {0}: {1}".format(status, output.decode("utf-8", "replace").strip()))
+		received += 1
+	return time.monotonic() - start, failures
+
+if __name__ == "__main__":
+	import argparse
+	
+	argparser = argparse.ArgumentParser(description="""
+		Benchmarks the tracer's command socket by running cycles of commands, by default saving, loading and
+		advancing a frame.
+	""")
+	argparser.add_argument("path", help="Path of the tracer's command socket")
+	argparser.add_argument("-n", "--cycles", type=int, default=1000, help="Number of cycles to run")
+	argparser.add_argument("-d", "--depth", type=int, default=16, help="Number of cycles to send ahead of the responses")
+	argparser.add_argument("-s", "--state", default="socket-bench", help="Name of the state to save and load")
+	argparser.add_argument("-q", "--quit", action="store_true", help="Quit the tracer when done")
+	argparser.add_argument("commands", nargs="*", help="Commands to run in each cycle, instead of the default ones")
+	
+	args = argparser.parse_args()
+	commands = args.commands or ["save " + args.state, "load " + args.state, "advance 1"]
+	
+	client = CommandClient(args.path)
+	seconds, failures = bench(client, commands, args.cycles, max(args.depth, 1))
+	requests = args.cycles * len(commands)
+	print("{0} cycles of {1} commands in {2:.2f} s: {3:.1f} cycles/s, {4:.1f} commands/s, {5} failed".format(
+		args.cycles, len(commands), seconds, args.cycles / seconds, requests / seconds, failures))
+	
+	if args.quit:
+		client.run("quit")
+	client.close()
@@ -0,0 +1,33 @@
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+
+void lss_pause();
+
+// Fills a large heap allocation, then modifies a few pages per frame.
+// Used to measure saving and loading large processes (see the `bench-memory` shell command).
+int main(int argc, char** argv) {
+	size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 512;
+	size_t size = megabytes*1024*1024;
+	
+	uint8_t* buf = malloc(size);
+	if(buf == NULL) {
+		fprintf(stderr, "could not allocate %zu MB\n", megabytes);
+		return 1;
+	}
+	for(size_t i=0; i<size; i++)
+		buf[i] = (uint8_t) (i / 4096);
+	
+	printf("PID: %d\nAllocated %zu MB at %p\n", getpid(), megabytes, (void*)buf);
+	
+	for(int frame=0; frame<10; frame++) {
+		for(int page=0; page<4; page++)
+			buf[((size_t)frame*4 + page)*4096] ^= 0xff;
+		lss_pause();
+	}
+	
+	free(buf);
+	return 0;
+}
@@ -0,0 +1,130 @@
+#define GL_GLEXT_PROTOTYPES 1
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <X11/Xlib.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/glx.h>
+#include <assert.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include "common.c"
+
+// Measures glReadPixels throughput for 1080p frames, read straight into memory and through a pixel pack buffer.
+
+#define WIDTH 1920
+#define HEIGHT 1080
+#define FRAMES 60
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char* name, double seconds, size_t frameBytes) {
+	printf("%-24s %8.2f ms/frame %8.1f MiB/s\n", name, seconds * 1000 / FRAMES,
+		(double) frameBytes * FRAMES / seconds / (1024*1024));
+}
+
+static void benchDirect(const char* name, GLenum format, GLenum type, size_t pixelBytes, uint8_t* pixels) {
+	glReadPixels(0, 0, WIDTH, HEIGHT, format, type, pixels); // Warm up
+	
+	double start = now();
+	for(int i = 0; i < FRAMES; i++) {
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glReadPixels(0, 0, WIDTH, HEIGHT, format, type, pixels);
+	}
+	report(name, now() - start, WIDTH * HEIGHT * pixelBytes);
+}
+
+static void benchBuffer(const char* name, GLenum format, GLenum type, size_t pixelBytes, uint8_t* pixels) {
+	size_t size = WIDTH * HEIGHT * pixelBytes;
+	GLuint pbo;
+	glGenBuffers(1, &pbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+	glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+	
+	double start = now();
+	for(int i = 0; i < FRAMES; i++) {
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glReadPixels(0, 0, WIDTH, HEIGHT, format, type, NULL);
+		void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+		assert(mapped != NULL);
+		memcpy(pixels, mapped, size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	report(name, now() - start, size);
+	
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glDeleteBuffers(1, &pbo);
+}
+
+static void checkPixels(const uint8_t* pixels) {
+	// Cleared to (0.25, 0.5, 0.75, 1.0)
+	for(int i = 0; i < WIDTH * HEIGHT; i += WIDTH + 1) {
+		const uint8_t* p = pixels + i*4;
+		if(abs(p[0] - 64) > 1 || abs(p[1] - 128) > 1 || abs(p[2] - 191) > 1 || p[3] != 255) {
+			printf("Mismatch: At pixel %d, got %d %d %d %d\n", i, p[0], p[1], p[2], p[3]);
+			return;
+		}
+	}
+}
+
+int main() {
+	Display* display;
+	Window window;
+	GLXContext context;
+	printf("Creating context.\n");
+	createContext(&display, &window, &context);
+	
+	printf("Creating framebuffer.\n");
+	GLuint fbo, renderbuffers[2];
+	glGenFramebuffers(1, &fbo);
+	glGenRenderbuffers(2, renderbuffers);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+	assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	
+	glViewport(0, 0, WIDTH, HEIGHT);
+	glClearColor(0.25, 0.5, 0.75, 1.0);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	
+	uint8_t* pixels = malloc(WIDTH * HEIGHT * 4);
+	assert(pixels != NULL);
+	
+	// ----------------------------------------------------------
+	printf("[] Checking colour readback\n");
+	memset(pixels, 0, WIDTH * HEIGHT * 4);
+	glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	checkPixels(pixels);
+	
+	printf("[] Readback of %d %dx%d frames\n", FRAMES, WIDTH, HEIGHT);
+	benchDirect("RGBA8", GL_RGBA, GL_UNSIGNED_BYTE, 4, pixels);
+	checkPixels(pixels);
+	benchDirect("BGRA8", GL_BGRA, GL_UNSIGNED_BYTE, 4, pixels);
+	benchDirect("Depth float", GL_DEPTH_COMPONENT, GL_FLOAT, 4, pixels);
+	benchBuffer("RGBA8 through a PBO", GL_RGBA, GL_UNSIGNED_BYTE, 4, pixels);
+	checkPixels(pixels);
+	
+	// ----------------------------------------------------------
+	
+	printf("Deleting.\n");
+	free(pixels);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteRenderbuffers(2, renderbuffers);
+	glFlush();
+	
+	printf("Closing.\n");
+	destroyContext(display, window, context);
+}
@@ -4,6 +4,7 @@
 #include <sys/types.h>
 #include <sys/syscall.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
 
 #ifdef __x86_64__
 	#include "syscalls.x64.c"
@@ -14,35 +15,185 @@
 #include "tracee.h"
 #include "gl/gl.h"
 
-/// Initializes the GL command stream buffer.
+#ifndef MAP_FIXED_NOREPLACE
+	#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#define LSS_GL_RING_MAP_SIZE (LSS_GL_RING_HEADER_SIZE + LSS_GL_RING_SIZE)
+
+/// Initializes the GL command stream buffer, and maps the shared-memory ring if the tracer provided one.
 void initGlBuffer(void) {
 	traceeData->gl.buffer = (void*) syscall6(
-		SYS_mmap, NULL, LSS_GL_BUFFER_SIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, 0, 0);
+		SYS_mmap, NULL, LSS_GL_BUFFER_MAX_SIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, 0, 0);
 	if(traceeData->gl.buffer == MAP_FAILED)
 		fail("could not allocate gl commands buffer");
 	
 	traceeData->gl.bufferEnd = 0;
+	traceeData->gl.bufferSize = LSS_GL_BUFFER_MIN_SIZE;
+	traceeData->gl.bufferHighWater = 0;
+	traceeData->gl.frameBytes = 0;
+	traceeData->gl.smallFrames = 0;
+	traceeData->gl.ring = NULL;
+	
+	// Fails if the tracer didn't pass a ring; the GL pipe is used then.
+	long ring = syscall6(SYS_mmap, LSS_GL_RING_ADDR, LSS_GL_RING_MAP_SIZE, PROT_READ|PROT_WRITE,
+		MAP_SHARED|MAP_FIXED_NOREPLACE, TRACEE_GL_RING_FD, 0);
+	if((void*) ring == LSS_GL_RING_ADDR) {
+		traceeData->gl.ring = (lss_gl_ring*) ring;
+		__atomic_store_n(&traceeData->gl.ring->mapped, 1, __ATOMIC_RELEASE);
+	} else if(ring > 0) {
+		// Kernels without MAP_FIXED_NOREPLACE treat the address as a hint
+		syscall2(SYS_munmap, ring, LSS_GL_RING_MAP_SIZE);
+	}
+	syscall1(SYS_close, TRACEE_GL_RING_FD);
 }
 
-void queueGlCommand(const void* cmd, size_t len) {
-	if(len > LSS_GL_BUFFER_SIZE - traceeData->gl.bufferEnd) {
-		// buffer filled, flush it
-		flushGlBuffer();
+/// Wakes the tracer to read the ring.
+static void signalRingData(void) {
+	uint64_t one = 1;
+	syscall3(SYS_write, TRACEE_GL_RING_DATA_FD, &one, sizeof(one));
+}
+
+/// Blocks until the tracer has read some of the ring, which is full up to `head`.
+static void waitForRingSpace(lss_gl_ring* ring, uint64_t head) {
+	signalRingData();
+	__atomic_store_n(&ring->producerWaiting, 1, __ATOMIC_SEQ_CST);
+	// The tracer checks producerWaiting after moving the tail, so one of the two sides sees the other's change.
+	if(head - __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST) == LSS_GL_RING_SIZE) {
+		uint64_t count;
+		readData(TRACEE_GL_RING_SPACE_FD, &count, sizeof(count));
+	}
+	__atomic_store_n(&ring->producerWaiting, 0, __ATOMIC_SEQ_CST);
+}
+
+/// Copies data into the ring, waiting for the tracer to make room if it's full.
+static void writeRing(lss_gl_ring* ring, const void* data, size_t len) {
+	uint8_t* area = (uint8_t*) ring + LSS_GL_RING_HEADER_SIZE;
+	const uint8_t* in = data;
+	uint64_t head = ring->head;
+	
+	while(len > 0) {
+		uint64_t used = head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if(used == LSS_GL_RING_SIZE) {
+			waitForRingSpace(ring, head);
+			continue;
+		}
 		
-		if(len > LSS_GL_BUFFER_SIZE) {
-			// Too big for the buffer
-			writeData(TRACEE_GL_WRITE_FD, cmd, len);
-			return;
+		size_t offset = head & (LSS_GL_RING_SIZE-1);
+		size_t amount = LSS_GL_RING_SIZE - used;
+		if(amount > LSS_GL_RING_SIZE - offset)
+			amount = LSS_GL_RING_SIZE - offset;
+		if(amount > len)
+			amount = len;
+		
+		__builtin_memcpy(area+offset, in, amount);
+		in += amount;
+		len -= amount;
+		head += amount;
+		__atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+	}
+}
+
+/// Selects the transport for GL commands. Used after loading a state, whose data may name a different transport.
+void setGlRing(int useRing) {
+	traceeData->gl.ring = useRing ? LSS_GL_RING_ADDR : NULL;
+	
+	// Commands that the loaded state had buffered for the pipe go through the ring instead
+	if(traceeData->gl.ring != NULL && traceeData->gl.bufferEnd != 0) {
+		writeRing(traceeData->gl.ring, traceeData->gl.buffer, traceeData->gl.bufferEnd);
+		traceeData->gl.bufferEnd = 0;
+	}
+}
+
+/// Writes the buffered commands to the GL pipe, followed by `len` bytes of `data`, without copying `data`.
+static void writeBufferAnd(const void* data, size_t len) {
+	struct iovec iov[2] = {
+		{ traceeData->gl.buffer, traceeData->gl.bufferEnd },
+		{ (void*) data, len },
+	};
+	struct iovec* current = iov;
+	int count = 2;
+	
+	while(count > 0) {
+		ssize_t written = syscall3(SYS_writev, TRACEE_GL_WRITE_FD, current, count);
+		if(written <= 0)
+			fail("could not write to GL pipe");
+		
+		// Skip past what was written; pipes may take a partial write.
+		while(count > 0 && (size_t) written >= current->iov_len) {
+			written -= current->iov_len;
+			current++;
+			count--;
 		}
+		if(count > 0) {
+			current->iov_base = (char*) current->iov_base + written;
+			current->iov_len -= written;
+		}
+	}
+	traceeData->gl.bufferEnd = 0;
+}
+
+void queueGlCommand(const void* cmd, size_t len) {
+	// Any command may cause an error
+	traceeData->gl.shadow.noError = 0;
+	
+	if(traceeData->gl.ring != NULL) {
+		// Written in place; the tracer reads straight out of the ring.
+		writeRing(traceeData->gl.ring, cmd, len);
+		return;
+	}
+	
+	if(len > traceeData->gl.bufferSize / 2) {
+		// Large data, like textures and vertex uploads, is sent along with the buffer instead of being copied into it.
+		// Smaller commands are still batched, since each direct send is a write that wakes the tracer.
+		writeBufferAnd(cmd, len);
+		return;
 	}
 	
+	if(len > traceeData->gl.bufferSize - traceeData->gl.bufferEnd)
+		flushGlBuffer();
+	
 	__builtin_memcpy(traceeData->gl.buffer+traceeData->gl.bufferEnd,
 		cmd, len);
 	traceeData->gl.bufferEnd += len;
+	traceeData->gl.frameBytes += len;
+	if(traceeData->gl.bufferEnd > traceeData->gl.bufferHighWater)
+		traceeData->gl.bufferHighWater = traceeData->gl.bufferEnd;
 }
 
 void flushGlBuffer(void) {
+	if(traceeData->gl.ring != NULL) {
+		signalRingData();
+		return;
+	}
+	
 	writeData(TRACEE_GL_WRITE_FD, traceeData->gl.buffer, traceeData->gl.bufferEnd);
 	traceeData->gl.bufferEnd = 0;
 }
 
+/// Flushes the frame's commands, and resizes the command buffer to fit the commands of a frame.
+void endGlFrame(void) {
+	flushGlBuffer();
+	if(traceeData->gl.ring != NULL)
+		return;
+	
+	size_t target = LSS_GL_BUFFER_MIN_SIZE;
+	while(target < traceeData->gl.frameBytes && target < LSS_GL_BUFFER_MAX_SIZE)
+		target *= 2;
+	traceeData->gl.frameBytes = 0;
+	
+	if(target > traceeData->gl.bufferSize) {
+		traceeData->gl.bufferSize = target;
+		traceeData->gl.smallFrames = 0;
+	} else if(target < traceeData->gl.bufferSize / 4) {
+		if(++traceeData->gl.smallFrames < LSS_GL_SHRINK_FRAMES)
+			return;
+		
+		// Give the unused part back to the kernel
+		syscall3(SYS_madvise, traceeData->gl.buffer + target, traceeData->gl.bufferSize - target, MADV_DONTNEED);
+		traceeData->gl.bufferSize = target;
+		traceeData->gl.smallFrames = 0;
+	} else {
+		traceeData->gl.smallFrames = 0;
+	}
+}
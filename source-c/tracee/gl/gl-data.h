@@ -2,11 +2,110 @@
 #ifndef _LSS_GL_DATA
 #define _LSS_GL_DATA
 
-#define LSS_GL_BUFFER_SIZE 16384
+#include <stdint.h>
+
+/// Smallest and largest sizes of the GL command buffer. The buffer is sized to fit a frame's commands.
+#define LSS_GL_BUFFER_MIN_SIZE 16384
+#define LSS_GL_BUFFER_MAX_SIZE (1024*1024)
+/// Number of frames that must use less than a quarter of the command buffer before it shrinks.
+#define LSS_GL_SHRINK_FRAMES 120
+
+/// Size of the shared-memory ring's data area. Must be a power of two.
+#define LSS_GL_RING_SIZE (4*1024*1024)
+/// Offset of the data area from the start of the ring's mapping.
+#define LSS_GL_RING_HEADER_SIZE 4096
+/// Fixed address that the tracee maps the ring at, so that pointers to it stay valid across loaded states.
+#define LSS_GL_RING_ADDR ((void*) 0x6f0000000000)
+
+/// Header of the shared-memory ring carrying the OpenGL command stream to the tracer.
+/// Must match `RingHeader` in `source/procinfo/glring.d`.
+typedef struct {
+	/// Total number of bytes written to the ring. Only written by the tracee.
+	uint64_t head;
+	uint8_t pad1[56];
+	/// Total number of bytes read from the ring. Only written by the tracer.
+	uint64_t tail;
+	uint8_t pad2[56];
+	/// Set by the tracee while it waits for the tracer to free space in the ring.
+	uint32_t producerWaiting;
+	/// Set by the tracee once it has mapped the ring.
+	uint32_t mapped;
+} lss_gl_ring;
+
+/// Next object names to hand out. The tracee picks the names for these objects itself, so that generating them
+/// doesn't wait for the tracer.
+typedef struct {
+	uint32_t buffers;
+	uint32_t textures;
+} lss_gl_names;
+
+// Bits of lss_gl_shadow.known
+#define LSS_GL_SHADOW_ARRAY_BUFFER   0x1
+#define LSS_GL_SHADOW_PROGRAM        0x2
+#define LSS_GL_SHADOW_ACTIVE_TEXTURE 0x4
+#define LSS_GL_SHADOW_VIEWPORT       0x8
+#define LSS_GL_SHADOW_PIXEL_PACK_BUFFER 0x10
+
+/// Copy of OpenGL state that the tracee tracks from its own calls, to answer queries without waiting for the tracer.
+/// See gl/shadow.c.
+typedef struct {
+	/// Set of the LSS_GL_SHADOW_* values that are known
+	uint32_t known;
+	/// Set if glGetError returned GL_NO_ERROR and no commands have been sent since.
+	uint32_t noError;
+	uint32_t arrayBufferBinding;
+	uint32_t pixelPackBufferBinding;
+	uint32_t currentProgram;
+	uint32_t activeTexture;
+	int32_t viewport[4];
+	/// Sets of the shadowed capabilities that are known, and of those that are enabled. See shadowCapBit.
+	uint32_t knownCaps;
+	/// ditto
+	uint32_t enabledCaps;
+} lss_gl_shadow;
+
+/// Most buffers that can be mapped at once.
+#define LSS_GL_MAX_MAPPINGS 16
+
+/// A buffer that the program has mapped. See gl/map.c.
+typedef struct {
+	/// Target that the buffer was last mapped, flushed or unmapped through, or 0 if it was by name. Changes are
+	/// sent through it, since the buffer bound to the target when it was mapped may not be bound anymore.
+	uint32_t target;
+	/// Name of the buffer. Mappings made through a target are keyed by the buffer bound to it.
+	uint32_t buffer;
+	/// GL_MAP_*_BIT flags that the buffer was mapped with.
+	uint32_t access;
+	uint32_t pad;
+	/// Mapped range of the buffer
+	int64_t offset;
+	/// ditto
+	int64_t length;
+	/// Memory handed to the program, or NULL if this slot is unused.
+	uint8_t* memory;
+	/// The range's contents as the tracer has them, to find what the program changed. NULL if the range was
+	/// invalidated when it was mapped, so its contents are unknown.
+	uint8_t* uploaded;
+} lss_gl_mapping;
 
 typedef struct {
 	void* buffer;
 	size_t bufferEnd;
+	/// Size of the command buffer that's in use. LSS_GL_BUFFER_MAX_SIZE bytes are reserved at `buffer`, so that
+	/// resizing it doesn't change the process' memory maps.
+	size_t bufferSize;
+	/// Most bytes that have been in the command buffer at once.
+	size_t bufferHighWater;
+	/// Bytes buffered during the current frame, and the number of frames in a row that would fit in a quarter
+	/// of the buffer.
+	size_t frameBytes;
+	/// ditto
+	uint32_t smallFrames;
+	/// Ring that GL commands are written to, or NULL to write them to the GL pipe through `buffer`.
+	lss_gl_ring* ring;
+	lss_gl_names names;
+	lss_gl_shadow shadow;
+	lss_gl_mapping mappings[LSS_GL_MAX_MAPPINGS];
 } lss_gl_data;
 
 #endif
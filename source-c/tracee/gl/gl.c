@@ -7,6 +7,8 @@
 #include "gl/gl.h"
 #include "gl/buffer.h"
 #include "gl/gl-generated.h"
+#include "gl/shadow.h"
+#include "gl/map.h"
 
 EXPORT void glFlush() {
 	int cmd = _LSS_GL_glFlush;
@@ -29,10 +31,32 @@ EXPORT void glGetBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,
 	
 	queueGlCommand(&params, sizeof(params));
 	flushGlBuffer();
-	readData(TRACEE_GL_READ_FD, data, size);
+	readFull(TRACEE_GL_READ_FD, data, size);
+}
+
+EXPORT void glGetNamedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, void *data) {
+	struct {
+		int cmd;
+		GLuint buffer;
+		GLintptr offset;
+		GLsizeiptr size;
+	} __attribute__((packed)) params = {
+		_LSS_GL_glGetNamedBufferSubData,
+		buffer,
+		offset,
+		size
+	};
+	
+	queueGlCommand(&params, sizeof(params));
+	flushGlBuffer();
+	readFull(TRACEE_GL_READ_FD, data, size);
 }
 
 EXPORT void glGetBufferParameteriv(GLenum target, GLenum param, GLint* data) {
+	// Mappings are made in the tracee, so the tracer doesn't know about them
+	if(mappedBufferParameter(target, 0, param, data))
+		return;
+	
 	struct {
 		int cmd;
 		GLenum target;
@@ -47,3 +71,182 @@ EXPORT void glGetBufferParameteriv(GLenum target, GLenum param, GLint* data) {
 	flushGlBuffer();
 	readData(TRACEE_GL_READ_FD, data, sizeof(GLint));
 }
+
+EXPORT void glGetNamedBufferParameteriv(GLuint buffer, GLenum param, GLint* data) {
+	if(mappedBufferParameter(0, buffer, param, data))
+		return;
+	
+	struct {
+		int cmd;
+		GLuint buffer;
+		GLenum param;
+	} __attribute__((packed)) params = {
+		_LSS_GL_glGetNamedBufferParameteriv,
+		buffer,
+		param
+	};
+	
+	queueGlCommand(&params, sizeof(params));
+	flushGlBuffer();
+	readData(TRACEE_GL_READ_FD, data, sizeof(GLint));
+}
+
+EXPORT GLenum glGetError(void) {
+	// Errors only come from commands, so none can have happened since the last check that found none.
+	if(traceeData->gl.shadow.noError)
+		return GL_NO_ERROR;
+	
+	int cmd = _LSS_GL_glGetError;
+	queueGlCommand(&cmd, sizeof(cmd));
+	flushGlBuffer();
+	
+	GLenum result;
+	readData(TRACEE_GL_READ_FD, &result, sizeof(result));
+	traceeData->gl.shadow.noError = result == GL_NO_ERROR;
+	return result;
+}
+
+EXPORT GLboolean glIsEnabled(GLenum cap) {
+	GLboolean result;
+	if(shadowIsEnabled(cap, &result))
+		return result;
+	
+	struct {
+		int cmd;
+		GLenum cap;
+	} __attribute__((packed)) params = {
+		_LSS_GL_glIsEnabled,
+		cap
+	};
+	
+	queueGlCommand(&params, sizeof(params));
+	flushGlBuffer();
+	readData(TRACEE_GL_READ_FD, &result, sizeof(result));
+	shadowSetEnabled(cap, result);
+	return result;
+}
+
+EXPORT void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels) {
+	// With a pixel pack buffer bound, the pixels go into the buffer, and there's nothing to wait for.
+	GLint packBuffer;
+	glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer);
+	
+	struct {
+		int cmd;
+		GLint x, y;
+		GLsizei width, height;
+		GLenum format, type;
+		uint64_t offset;
+		GLuint packBuffer;
+	} __attribute__((packed)) params = {
+		_LSS_GL_glReadPixels,
+		x, y,
+		width, height,
+		format, type,
+		(uint64_t) pixels,
+		packBuffer
+	};
+	
+	queueGlCommand(&params, sizeof(params));
+	if(packBuffer != 0)
+		return;
+	
+	// The tracer reads the pixels tightly packed, and says where the program's pack state puts each row.
+	struct {
+		uint64_t start;
+		uint64_t stride;
+		uint32_t rowBytes;
+		uint32_t rows;
+	} __attribute__((packed)) layout;
+	flushGlBuffer();
+	readData(TRACEE_GL_READ_FD, &layout, sizeof(layout));
+	
+	uint8_t* dest = (uint8_t*) pixels + layout.start;
+	if(layout.stride == layout.rowBytes) {
+		readFull(TRACEE_GL_READ_FD, dest, (size_t) layout.rowBytes * layout.rows);
+		return;
+	}
+	for(uint32_t row = 0; row < layout.rows; row++)
+		readFull(TRACEE_GL_READ_FD, dest + row * layout.stride, layout.rowBytes);
+}
+
+/// Length of a list returned by glGetIntegerv, from the parameter that holds it.
+static uint32_t getIntegervListCount(GLenum countPname) {
+	GLint count = 0;
+	glGetIntegerv(countPname, &count);
+	return count > 0 ? count : 0;
+}
+
+/// Number of values that glGetIntegerv returns for a parameter. Parameters that aren't listed return one value.
+static uint32_t getIntegervCount(GLenum pname) {
+	switch(pname) {
+	case GL_VIEWPORT:
+	case GL_SCISSOR_BOX:
+	case GL_COLOR_WRITEMASK:
+	case GL_COLOR_CLEAR_VALUE:
+	case GL_BLEND_COLOR:
+	// Compatibility profile
+	case GL_CURRENT_COLOR:
+	case GL_CURRENT_SECONDARY_COLOR:
+	case GL_CURRENT_TEXTURE_COORDS:
+	case GL_CURRENT_RASTER_COLOR:
+	case GL_CURRENT_RASTER_SECONDARY_COLOR:
+	case GL_CURRENT_RASTER_POSITION:
+	case GL_CURRENT_RASTER_TEXTURE_COORDS:
+	case GL_FOG_COLOR:
+	case GL_LIGHT_MODEL_AMBIENT:
+	case GL_ACCUM_CLEAR_VALUE:
+	case GL_MAP2_GRID_DOMAIN:
+		return 4;
+	case GL_CURRENT_NORMAL:
+		return 3;
+	case GL_DEPTH_RANGE:
+	case GL_MAX_VIEWPORT_DIMS:
+	case GL_POLYGON_MODE:
+	case GL_ALIASED_LINE_WIDTH_RANGE:
+	case GL_SMOOTH_LINE_WIDTH_RANGE:
+	case GL_ALIASED_POINT_SIZE_RANGE:
+	case GL_POINT_SIZE_RANGE:
+	case GL_VIEWPORT_BOUNDS_RANGE:
+	case GL_DEPTH_BOUNDS_EXT:
+	case GL_MAP1_GRID_DOMAIN:
+	case GL_MAP2_GRID_SEGMENTS:
+		return 2;
+	case GL_MODELVIEW_MATRIX:
+	case GL_PROJECTION_MATRIX:
+	case GL_TEXTURE_MATRIX:
+	case GL_COLOR_MATRIX:
+	case GL_TRANSPOSE_MODELVIEW_MATRIX:
+	case GL_TRANSPOSE_PROJECTION_MATRIX:
+	case GL_TRANSPOSE_TEXTURE_MATRIX:
+	case GL_TRANSPOSE_COLOR_MATRIX:
+		return 16;
+	case GL_COMPRESSED_TEXTURE_FORMATS:
+		return getIntegervListCount(GL_NUM_COMPRESSED_TEXTURE_FORMATS);
+	case GL_PROGRAM_BINARY_FORMATS:
+		return getIntegervListCount(GL_NUM_PROGRAM_BINARY_FORMATS);
+	case GL_SHADER_BINARY_FORMATS:
+		return getIntegervListCount(GL_NUM_SHADER_BINARY_FORMATS);
+	default:
+		return 1;
+	}
+}
+
+EXPORT void glGetIntegerv(GLenum pname, GLint* data) {
+	if(shadowGetIntegerv(pname, data))
+		return;
+	
+	struct {
+		int cmd;
+		GLenum pname;
+		uint32_t count;
+	} __attribute__((packed)) params = {
+		_LSS_GL_glGetIntegerv,
+		pname,
+		getIntegervCount(pname)
+	};
+	
+	queueGlCommand(&params, sizeof(params));
+	flushGlBuffer();
+	readData(TRACEE_GL_READ_FD, data, params.count * sizeof(GLint));
+}
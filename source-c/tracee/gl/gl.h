@@ -5,5 +5,7 @@
 void initGlBuffer(void);
 void queueGlCommand(const void* cmd, size_t len);
 void flushGlBuffer(void);
+void setGlRing(int useRing);
+void endGlFrame(void);
 
 #endif
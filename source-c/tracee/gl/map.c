@@ -0,0 +1,296 @@
+
+#define GL_GLEXT_PROTOTYPES 1
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#ifdef __x86_64__
+	#include "syscalls.x64.c"
+#else
+	#include "syscalls.i86.c"
+#endif
+
+#include "tracee.h"
+#include "gl/map.h"
+
+/*
+ * Buffer mapping, done in the tracee.
+ *
+ * The tracer's buffers live in another process, so the program is handed shadow memory instead. When a range is
+ * mapped, its contents are read back from the tracer, and a second copy is kept of what the tracer has. Flushing or
+ * unmapping compares the two, and sends only the changed runs with glBufferSubData. Ranges mapped with an
+ * invalidate bit have undefined contents, so they aren't read back, and are sent whole.
+ *
+ * The mappings are in traceeData and the shadow memory is part of the process, so a state saved while a buffer is
+ * mapped restores both along with the tracer's copy of the buffer.
+ */
+
+#define PAGE_SIZE 4096
+/// Bytes compared at a time when looking for changes.
+#define DIFF_BLOCK 64
+/// Changed blocks closer than this are sent as one range, since each command has overhead of its own.
+#define DIFF_MERGE_GAP 256
+
+static size_t pageRound(size_t size) {
+	return (size + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+}
+
+/// Name of the buffer bound to a target, or 0 if there is none or the target isn't a buffer target.
+static GLuint boundBuffer(GLenum target) {
+	GLenum binding;
+	switch(target) {
+	case GL_ARRAY_BUFFER:              binding = GL_ARRAY_BUFFER_BINDING; break;
+	case GL_ELEMENT_ARRAY_BUFFER:      binding = GL_ELEMENT_ARRAY_BUFFER_BINDING; break;
+	case GL_PIXEL_PACK_BUFFER:         binding = GL_PIXEL_PACK_BUFFER_BINDING; break;
+	case GL_PIXEL_UNPACK_BUFFER:       binding = GL_PIXEL_UNPACK_BUFFER_BINDING; break;
+	case GL_COPY_READ_BUFFER:          binding = GL_COPY_READ_BUFFER_BINDING; break;
+	case GL_COPY_WRITE_BUFFER:         binding = GL_COPY_WRITE_BUFFER_BINDING; break;
+	case GL_UNIFORM_BUFFER:            binding = GL_UNIFORM_BUFFER_BINDING; break;
+	case GL_TEXTURE_BUFFER:            binding = GL_TEXTURE_BUFFER_BINDING; break;
+	case GL_TRANSFORM_FEEDBACK_BUFFER: binding = GL_TRANSFORM_FEEDBACK_BUFFER_BINDING; break;
+	case GL_SHADER_STORAGE_BUFFER:     binding = GL_SHADER_STORAGE_BUFFER_BINDING; break;
+	case GL_ATOMIC_COUNTER_BUFFER:     binding = GL_ATOMIC_COUNTER_BUFFER_BINDING; break;
+	case GL_DRAW_INDIRECT_BUFFER:      binding = GL_DRAW_INDIRECT_BUFFER_BINDING; break;
+	case GL_DISPATCH_INDIRECT_BUFFER:  binding = GL_DISPATCH_INDIRECT_BUFFER_BINDING; break;
+	case GL_QUERY_BUFFER:              binding = GL_QUERY_BUFFER_BINDING; break;
+	default:                           return 0;
+	}
+	
+	GLint buffer;
+	glGetIntegerv(binding, &buffer);
+	return buffer;
+}
+
+/// Finds the mapping of a buffer, given by name or by the target that it is bound to. Returns NULL if it isn't
+/// mapped.
+static lss_gl_mapping* findMapping(GLenum target, GLuint buffer) {
+	if(target != 0)
+		buffer = boundBuffer(target);
+	if(buffer == 0)
+		return NULL;
+	
+	for(int i = 0; i < LSS_GL_MAX_MAPPINGS; i++) {
+		lss_gl_mapping* mapping = &traceeData->gl.mappings[i];
+		if(mapping->memory != NULL && mapping->buffer == buffer)
+			return mapping;
+	}
+	return NULL;
+}
+
+/// Frees a mapping's memory and its slot.
+static void releaseMapping(lss_gl_mapping* mapping) {
+	size_t size = pageRound(mapping->length);
+	syscall2(SYS_munmap, (long) mapping->memory, mapping->uploaded != NULL ? 2*size : size);
+	mapping->memory = NULL;
+	mapping->uploaded = NULL;
+}
+
+/// Sends part of the mapped range to the tracer. `start` and `end` are relative to the mapping.
+static void sendRange(lss_gl_mapping* mapping, size_t start, size_t end) {
+	if(mapping->target != 0)
+		glBufferSubData(mapping->target, mapping->offset + start, end - start, mapping->memory + start);
+	else
+		glNamedBufferSubData(mapping->buffer, mapping->offset + start, end - start, mapping->memory + start);
+	
+	if(mapping->uploaded != NULL)
+		__builtin_memcpy(mapping->uploaded + start, mapping->memory + start, end - start);
+}
+
+static int blockChanged(const uint8_t* a, const uint8_t* b, size_t len) {
+	// The blocks are 8-byte aligned, except for the end of the range
+	size_t i = 0;
+	for(; i + 8 <= len; i += 8) {
+		if(*(const uint64_t*)(a+i) != *(const uint64_t*)(b+i))
+			return 1;
+	}
+	for(; i < len; i++) {
+		if(a[i] != b[i])
+			return 1;
+	}
+	return 0;
+}
+
+/// Sends the parts of the mapped range between `start` and `end` that the program changed.
+static void sendChanges(lss_gl_mapping* mapping, size_t start, size_t end) {
+	if(mapping->uploaded == NULL) {
+		sendRange(mapping, start, end);
+		return;
+	}
+	
+	size_t runStart = 0, runEnd = 0;
+	int inRun = 0;
+	for(size_t pos = start; pos < end; pos += DIFF_BLOCK) {
+		size_t blockEnd = pos + DIFF_BLOCK < end ? pos + DIFF_BLOCK : end;
+		if(!blockChanged(mapping->memory + pos, mapping->uploaded + pos, blockEnd - pos))
+			continue;
+		
+		if(inRun && pos - runEnd <= DIFF_MERGE_GAP) {
+			runEnd = blockEnd;
+			continue;
+		}
+		if(inRun)
+			sendRange(mapping, runStart, runEnd);
+		runStart = pos;
+		runEnd = blockEnd;
+		inRun = 1;
+	}
+	if(inRun)
+		sendRange(mapping, runStart, runEnd);
+}
+
+static void* mapBuffer(GLenum target, GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+	if(access & GL_MAP_PERSISTENT_BIT)
+		fail("Persistent buffer mappings are unimplemented");
+	if(length <= 0 || offset < 0 || !(access & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT)))
+		return NULL; // GL_INVALID_VALUE or GL_INVALID_OPERATION
+	if(target != 0)
+		buffer = boundBuffer(target);
+	if(buffer == 0)
+		return NULL; // GL_INVALID_OPERATION or GL_INVALID_ENUM; no buffer bound to the target
+	if(findMapping(0, buffer) != NULL)
+		return NULL; // GL_INVALID_OPERATION; already mapped
+	
+	lss_gl_mapping* mapping = NULL;
+	for(int i = 0; i < LSS_GL_MAX_MAPPINGS && mapping == NULL; i++) {
+		if(traceeData->gl.mappings[i].memory == NULL)
+			mapping = &traceeData->gl.mappings[i];
+	}
+	if(mapping == NULL)
+		fail("Too many buffers are mapped at once");
+	
+	int invalidated = (access & (GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)) != 0;
+	size_t size = pageRound(length);
+	uint8_t* memory = (uint8_t*) syscall6(SYS_mmap, NULL, invalidated ? size : 2*size, PROT_READ|PROT_WRITE,
+		MAP_PRIVATE|MAP_ANONYMOUS, 0, 0);
+	if((void*) memory == MAP_FAILED)
+		fail("could not allocate memory for a mapped buffer");
+	
+	mapping->target = target;
+	mapping->buffer = buffer;
+	mapping->access = access;
+	mapping->offset = offset;
+	mapping->length = length;
+	mapping->memory = memory;
+	mapping->uploaded = NULL;
+	
+	if(!invalidated) {
+		if(target != 0)
+			glGetBufferSubData(target, offset, length, memory);
+		else
+			glGetNamedBufferSubData(buffer, offset, length, memory);
+		mapping->uploaded = memory + size;
+		__builtin_memcpy(mapping->uploaded, memory, length);
+	}
+	return memory;
+}
+
+static void flushMappedRange(GLenum target, GLuint buffer, GLintptr offset, GLsizeiptr length) {
+	lss_gl_mapping* mapping = findMapping(target, buffer);
+	if(mapping == NULL || !(mapping->access & GL_MAP_FLUSH_EXPLICIT_BIT))
+		return; // GL_INVALID_OPERATION
+	if(offset < 0 || length < 0 || offset + length > mapping->length)
+		return; // GL_INVALID_VALUE
+	
+	mapping->target = target;
+	sendChanges(mapping, offset, offset + length);
+}
+
+static GLboolean unmapBuffer(GLenum target, GLuint buffer) {
+	lss_gl_mapping* mapping = findMapping(target, buffer);
+	if(mapping == NULL)
+		return GL_FALSE; // GL_INVALID_OPERATION
+	
+	mapping->target = target;
+	// With explicit flushes, only the flushed ranges are defined to change
+	if((mapping->access & GL_MAP_WRITE_BIT) && !(mapping->access & GL_MAP_FLUSH_EXPLICIT_BIT))
+		sendChanges(mapping, 0, mapping->length);
+	
+	releaseMapping(mapping);
+	return GL_TRUE;
+}
+
+/// Converts the access enum of glMapBuffer to GL_MAP_*_BIT flags.
+static GLbitfield accessBits(GLenum access) {
+	switch(access) {
+	case GL_READ_ONLY:  return GL_MAP_READ_BIT;
+	case GL_WRITE_ONLY: return GL_MAP_WRITE_BIT;
+	case GL_READ_WRITE: return GL_MAP_READ_BIT | GL_MAP_WRITE_BIT;
+	default:            return 0;
+	}
+}
+
+EXPORT void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+	return mapBuffer(target, 0, offset, length, access);
+}
+
+EXPORT void* glMapBuffer(GLenum target, GLenum access) {
+	GLint size;
+	glGetBufferParameteriv(target, GL_BUFFER_SIZE, &size);
+	return mapBuffer(target, 0, 0, size, accessBits(access));
+}
+
+EXPORT void* glMapNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+	return mapBuffer(0, buffer, offset, length, access);
+}
+
+EXPORT void* glMapNamedBuffer(GLuint buffer, GLenum access) {
+	GLint size;
+	glGetNamedBufferParameteriv(buffer, GL_BUFFER_SIZE, &size);
+	return mapBuffer(0, buffer, 0, size, accessBits(access));
+}
+
+EXPORT void glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length) {
+	flushMappedRange(target, 0, offset, length);
+}
+
+EXPORT void glFlushMappedNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr length) {
+	flushMappedRange(0, buffer, offset, length);
+}
+
+EXPORT GLboolean glUnmapBuffer(GLenum target) {
+	return unmapBuffer(target, 0);
+}
+
+EXPORT GLboolean glUnmapNamedBuffer(GLuint buffer) {
+	return unmapBuffer(0, buffer);
+}
+
+/// Answers glGetBufferParameteriv for the mapping parameters. Returns 1 if it did, or 0 for other parameters.
+int mappedBufferParameter(GLenum target, GLuint buffer, GLenum pname, GLint* result) {
+	// Finding the buffer bound to the target may take a round trip, so only look for the mapping parameters
+	if(pname != GL_BUFFER_MAPPED && pname != GL_BUFFER_MAP_OFFSET && pname != GL_BUFFER_MAP_LENGTH &&
+		pname != GL_BUFFER_ACCESS_FLAGS)
+		return 0;
+	
+	lss_gl_mapping* mapping = findMapping(target, buffer);
+	switch(pname) {
+	case GL_BUFFER_MAPPED:
+		*result = mapping != NULL;
+		return 1;
+	case GL_BUFFER_MAP_OFFSET:
+		*result = mapping != NULL ? mapping->offset : 0;
+		return 1;
+	case GL_BUFFER_MAP_LENGTH:
+		*result = mapping != NULL ? mapping->length : 0;
+		return 1;
+	case GL_BUFFER_ACCESS_FLAGS:
+		*result = mapping != NULL ? mapping->access : 0;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/// Drops the mappings of deleted buffers; deleting a buffer unmaps it.
+void forgetMappedBuffers(GLsizei n, const GLuint* buffers) {
+	for(GLsizei i = 0; i < n; i++) {
+		lss_gl_mapping* mapping = findMapping(0, buffers[i]);
+		if(mapping != NULL)
+			releaseMapping(mapping);
+	}
+}
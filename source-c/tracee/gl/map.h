@@ -0,0 +1,11 @@
+
+#ifndef _LSS_GL_MAP
+#define _LSS_GL_MAP
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+int mappedBufferParameter(GLenum target, GLuint buffer, GLenum pname, GLint* result);
+void forgetMappedBuffers(GLsizei n, const GLuint* buffers);
+
+#endif
@@ -0,0 +1,182 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "tracee.h"
+#include "gl/shadow.h"
+#include "gl/map.h"
+
+/*
+ * The shadow state follows the tracee's own calls, assuming that they succeed. Calls that can restore state in
+ * bulk, such as glPopAttrib, make the affected values unknown, and queries for unknown values go to the tracer.
+ */
+
+/// Returns the bit of a shadowed capability in lss_gl_shadow.knownCaps/enabledCaps, or 0 if it isn't shadowed.
+static uint32_t shadowCapBit(GLenum cap) {
+	switch(cap) {
+	case GL_BLEND:        return 0x1;
+	case GL_CULL_FACE:    return 0x2;
+	case GL_DEPTH_TEST:   return 0x4;
+	case GL_SCISSOR_TEST: return 0x8;
+	case GL_STENCIL_TEST: return 0x10;
+	default:              return 0;
+	}
+}
+#define ALL_SHADOW_CAPS 0x1f
+
+/// Sets the shadow state to the defaults of a new context.
+void resetGlShadow(void) {
+	lss_gl_shadow* shadow = &traceeData->gl.shadow;
+	shadow->known = LSS_GL_SHADOW_ARRAY_BUFFER | LSS_GL_SHADOW_PIXEL_PACK_BUFFER | LSS_GL_SHADOW_PROGRAM |
+		LSS_GL_SHADOW_ACTIVE_TEXTURE;
+	shadow->noError = 1;
+	shadow->arrayBufferBinding = 0;
+	shadow->pixelPackBufferBinding = 0;
+	shadow->currentProgram = 0;
+	shadow->activeTexture = GL_TEXTURE0;
+	// The initial viewport is the window's size, which the tracer picks.
+	shadow->knownCaps = ALL_SHADOW_CAPS;
+	shadow->enabledCaps = 0;
+}
+
+/// Forgets all of the shadow state, so that all queries go to the tracer.
+void forgetGlShadow(void) {
+	traceeData->gl.shadow.known = 0;
+	traceeData->gl.shadow.noError = 0;
+	traceeData->gl.shadow.knownCaps = 0;
+}
+
+/// Answers glGetIntegerv from the shadow state. Returns 1 if it did, or 0 if the value isn't known.
+int shadowGetIntegerv(GLenum pname, GLint* data) {
+	lss_gl_shadow* shadow = &traceeData->gl.shadow;
+	GLboolean enabled;
+	
+	switch(pname) {
+	case GL_ARRAY_BUFFER_BINDING:
+		if(!(shadow->known & LSS_GL_SHADOW_ARRAY_BUFFER))
+			return 0;
+		*data = shadow->arrayBufferBinding;
+		return 1;
+	case GL_PIXEL_PACK_BUFFER_BINDING:
+		if(!(shadow->known & LSS_GL_SHADOW_PIXEL_PACK_BUFFER))
+			return 0;
+		*data = shadow->pixelPackBufferBinding;
+		return 1;
+	case GL_CURRENT_PROGRAM:
+		if(!(shadow->known & LSS_GL_SHADOW_PROGRAM))
+			return 0;
+		*data = shadow->currentProgram;
+		return 1;
+	case GL_ACTIVE_TEXTURE:
+		if(!(shadow->known & LSS_GL_SHADOW_ACTIVE_TEXTURE))
+			return 0;
+		*data = shadow->activeTexture;
+		return 1;
+	case GL_VIEWPORT:
+		if(!(shadow->known & LSS_GL_SHADOW_VIEWPORT))
+			return 0;
+		for(int i = 0; i < 4; i++)
+			data[i] = shadow->viewport[i];
+		return 1;
+	default:
+		if(!shadowIsEnabled(pname, &enabled))
+			return 0;
+		*data = enabled;
+		return 1;
+	}
+}
+
+/// Answers glIsEnabled from the shadow state. Returns 1 if it did, or 0 if the value isn't known.
+int shadowIsEnabled(GLenum cap, GLboolean* result) {
+	uint32_t bit = shadowCapBit(cap);
+	if(bit == 0 || !(traceeData->gl.shadow.knownCaps & bit))
+		return 0;
+	*result = (traceeData->gl.shadow.enabledCaps & bit) ? GL_TRUE : GL_FALSE;
+	return 1;
+}
+
+/// Records the state of a capability, from a call that changed it or a query answered by the tracer.
+void shadowSetEnabled(GLenum cap, GLboolean enabled) {
+	uint32_t bit = shadowCapBit(cap);
+	traceeData->gl.shadow.knownCaps |= bit;
+	if(enabled)
+		traceeData->gl.shadow.enabledCaps |= bit;
+	else
+		traceeData->gl.shadow.enabledCaps &= ~bit;
+}
+
+/// Hands out `n` new object names from the counter `next`.
+void reserveGlNames(uint32_t* next, GLsizei n, GLuint* names) {
+	if(*next == 0)
+		*next = 1;
+	for(GLsizei i = 0; i < n; i++)
+		names[i] = (*next)++;
+}
+
+void lss_shadow_glBindBuffer(GLenum target, GLuint buffer) {
+	if(target == GL_ARRAY_BUFFER)
+		traceeData->gl.shadow.arrayBufferBinding = buffer;
+	else if(target == GL_PIXEL_PACK_BUFFER)
+		traceeData->gl.shadow.pixelPackBufferBinding = buffer;
+}
+
+void lss_shadow_glDeleteBuffers(GLsizei n, const GLuint* buffers) {
+	forgetMappedBuffers(n, buffers);
+	
+	// Deleting a bound buffer unbinds it
+	for(GLsizei i = 0; i < n; i++) {
+		if(buffers[i] == 0)
+			continue;
+		if(buffers[i] == traceeData->gl.shadow.arrayBufferBinding)
+			traceeData->gl.shadow.arrayBufferBinding = 0;
+		if(buffers[i] == traceeData->gl.shadow.pixelPackBufferBinding)
+			traceeData->gl.shadow.pixelPackBufferBinding = 0;
+	}
+}
+
+void lss_shadow_glUseProgram(GLuint program) {
+	traceeData->gl.shadow.currentProgram = program;
+}
+
+void lss_shadow_glActiveTexture(GLenum texture) {
+	traceeData->gl.shadow.activeTexture = texture;
+}
+
+void lss_shadow_glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+	if(width < 0 || height < 0)
+		return; // GL_INVALID_VALUE; the viewport doesn't change
+	
+	traceeData->gl.shadow.viewport[0] = x;
+	traceeData->gl.shadow.viewport[1] = y;
+	traceeData->gl.shadow.viewport[2] = width;
+	traceeData->gl.shadow.viewport[3] = height;
+	traceeData->gl.shadow.known |= LSS_GL_SHADOW_VIEWPORT;
+}
+
+void lss_shadow_glEnable(GLenum cap) {
+	shadowSetEnabled(cap, GL_TRUE);
+}
+
+void lss_shadow_glDisable(GLenum cap) {
+	shadowSetEnabled(cap, GL_FALSE);
+}
+
+void lss_shadow_glEnablei(GLenum target, GLuint index) {
+	// Indexed capabilities alias the non-indexed one at index 0
+	(void) index;
+	traceeData->gl.shadow.knownCaps &= ~shadowCapBit(target);
+}
+
+void lss_shadow_glDisablei(GLenum target, GLuint index) {
+	lss_shadow_glEnablei(target, index);
+}
+
+void lss_shadow_glPopAttrib(void) {
+	traceeData->gl.shadow.knownCaps = 0;
+	traceeData->gl.shadow.known &= ~LSS_GL_SHADOW_VIEWPORT;
+}
+
+void lss_shadow_glPopClientAttrib(void) {
+	traceeData->gl.shadow.known &= ~(LSS_GL_SHADOW_ARRAY_BUFFER | LSS_GL_SHADOW_PIXEL_PACK_BUFFER);
+}
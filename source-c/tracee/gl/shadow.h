@@ -0,0 +1,29 @@
+
+#ifndef _LSS_GL_SHADOW
+#define _LSS_GL_SHADOW
+
+#include <stdint.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+void resetGlShadow(void);
+void forgetGlShadow(void);
+int shadowGetIntegerv(GLenum pname, GLint* data);
+int shadowIsEnabled(GLenum cap, GLboolean* result);
+void shadowSetEnabled(GLenum cap, GLboolean enabled);
+void reserveGlNames(uint32_t* next, GLsizei n, GLuint* names);
+
+// Hooks called by the generated wrappers after sending the command. See FUNCTION_SHADOWED in gen-gl-wrappers.py.
+void lss_shadow_glBindBuffer(GLenum target, GLuint buffer);
+void lss_shadow_glDeleteBuffers(GLsizei n, const GLuint* buffers);
+void lss_shadow_glUseProgram(GLuint program);
+void lss_shadow_glActiveTexture(GLenum texture);
+void lss_shadow_glViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+void lss_shadow_glEnable(GLenum cap);
+void lss_shadow_glDisable(GLenum cap);
+void lss_shadow_glEnablei(GLenum target, GLuint index);
+void lss_shadow_glDisablei(GLenum target, GLuint index);
+void lss_shadow_glPopAttrib(void);
+void lss_shadow_glPopClientAttrib(void);
+
+#endif
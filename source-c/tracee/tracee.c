@@ -69,6 +69,18 @@ void readData(int fd, void* out, size_t size) {
 		fail("could not read from the command pipe");
 }
 
+void readFull(int fd, void* out, size_t size) {
+	// Pipes return at most what is buffered, so large transfers take several reads
+	uint8_t* dest = (uint8_t*) out;
+	while(size > 0) {
+		ssize_t numRead = syscall3(SYS_read, fd, dest, size);
+		if(numRead <= 0)
+			fail("could not read from the command pipe");
+		dest += numRead;
+		size -= numRead;
+	}
+}
+
 void writeData(int fd, const void* in, size_t size) {
 	ssize_t numWrote = syscall3(SYS_write, fd, in, size);
 	if(numWrote != size)
@@ -91,13 +103,16 @@ void init() {
 	syscall3(SYS_write, 2, "lss debug: initialized\n", sizeof("lss debug: initialized\n")-1);
 }
 
-/// Processes one command from the command pipe
-int doOneCommand() {
-	// Get a command
+/// Reads a command ID from the command pipe
+static Wrapper2AppCmd readCommand() {
 	int32_t cmdInt;
 	readData(TRACEE_READ_FD, &cmdInt, sizeof(int32_t));
-	Wrapper2AppCmd cmd = (Wrapper2AppCmd) cmdInt;
-			
+	return (Wrapper2AppCmd) cmdInt;
+}
+
+/// Reads the arguments of a command from the command pipe and runs it.
+/// Returns 1 if the program should continue, or 0 if it should pause again.
+static int runCommand(Wrapper2AppCmd cmd) {
 	if(cmd == CMD_CONTINUE)
 		return 1;
 	else if(cmd == CMD_SETHEAP) {
@@ -166,12 +181,46 @@ int doOneCommand() {
 		} else {
 			fail("unrecognized clock type");
 		}
+	} else if(cmd == CMD_ADVANCE) {
+		uint64_t clocks[4];
+		readData(TRACEE_READ_FD, clocks, sizeof(clocks));
+		
+		traceeData->clocks.realtime.tv_sec = clocks[0];
+		traceeData->clocks.realtime.tv_nsec = clocks[1];
+		traceeData->clocks.monotonic.tv_sec = clocks[2];
+		traceeData->clocks.monotonic.tv_nsec = clocks[3];
+		return 1;
+	} else if(cmd == CMD_SETGLRING) {
+		int useRing;
+		readData(TRACEE_READ_FD, &useRing, sizeof(useRing));
+		setGlRing(useRing);
+	} else if(cmd == CMD_BATCH) {
+		fail("batches can't be nested");
 	} else {
 		fail("unrecognized command");
 	}
 	return 0;
 }
 
+/// Processes one command from the command pipe. A batch of commands counts as one command.
+/// Returns 1 if the program should continue, or 0 if it should pause again.
+int doOneCommand() {
+	Wrapper2AppCmd cmd = readCommand();
+	if(cmd != CMD_BATCH)
+		return runCommand(cmd);
+	
+	uint32_t count;
+	readData(TRACEE_READ_FD, &count, sizeof(count));
+	
+	int shouldContinue = 0;
+	for(uint32_t i = 0; i < count; i++)
+		shouldContinue |= runCommand(readCommand());
+	
+	int ack[2] = {CMD_BATCHDONE, count};
+	writeData(TRACEE_WRITE_FD, ack, sizeof(ack));
+	return shouldContinue;
+}
+
 EXPORT void lss_test_command(uint32_t val) {
 	int cmd = (int) CMD_TEST;
 	
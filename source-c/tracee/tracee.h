@@ -8,11 +8,14 @@
 
 #define EXPORT __attribute__((visibility("default")))
 
-#define TRACEE_DATA_VERSION 1
+#define TRACEE_DATA_VERSION 4
 #define TRACEE_READ_FD 500
 #define TRACEE_WRITE_FD 501
 #define TRACEE_GL_READ_FD 502
 #define TRACEE_GL_WRITE_FD 503
+#define TRACEE_GL_RING_FD 504
+#define TRACEE_GL_RING_DATA_FD 505
+#define TRACEE_GL_RING_SPACE_FD 506
 
 #include "x/x-data.h"
 #include "gl/gl-data.h"
@@ -54,6 +57,9 @@ __attribute__((noreturn)) void fail(const char* msg);
 
 /// Reads a value from the specified file descriptor and aborts on errors.
 void readData(int fd, void* out, size_t size);
+/// Reads `size` bytes from the specified file descriptor, however many reads it takes, and aborts on errors.
+/// Use this rather than `readData` for data that may not fit in the pipe.
+void readFull(int fd, void* out, size_t size);
 /// Writes a value to the specified file descriptor and aborts on errors.
 void writeData(int fd, const void* in, size_t size);
 
@@ -2,6 +2,7 @@
 #include "tracee.h"
 #include "x/x.h"
 #include "gl/gl.h"
+#include "gl/shadow.h"
 
 #define XLIB_ILLEGAL_ACCESS // Lets us access internals of X11 structs
 #include <X11/Xlib.h>
@@ -142,6 +143,7 @@ EXPORT GLXContext glXCreateContext(Display* display, XVisualInfo* visinfo, GLXCo
 		fail("Creating more than one context is unsupported");
 	
 	traceeData->x11.flags |= LSS_X_CONTEXT_OPENED;
+	resetGlShadow();
 	
 	// Return a dummy pointer
 	return (GLXContext) 0x1;
@@ -149,6 +151,7 @@ EXPORT GLXContext glXCreateContext(Display* display, XVisualInfo* visinfo, GLXCo
 
 EXPORT void glXDestroyContext(Display* display, GLXContext ctx) {
 	traceeData->x11.flags &= ~LSS_X_CONTEXT_OPENED;
+	forgetGlShadow();
 }
 
 EXPORT Bool glXMakeCurrent(Display* display, GLXDrawable drawable, GLXContext ctx) {
@@ -166,7 +169,7 @@ EXPORT __GLXextFuncPtr glXGetProcAddressARB(const GLubyte* name) {
 }
 
 EXPORT void glXSwapBuffers(Display* dpy, GLXDrawable drawable) {
-	flushGlBuffer();
+	endGlFrame();
 	
 	int cmd = (int) CMD_SWAPBUFFERS;
 	writeData(TRACEE_WRITE_FD, &cmd, sizeof(cmd));